@@ -17,6 +17,7 @@ void load_demo(std::string filename)
         table->header->records_cnt;
         table->col_defs[0]->field_name;
         table->records[0]->contents["STOCK_CODE"];
+        table->text(0, "STOCK_NAME"); // UTF-8, transcoded from table->header->code_page_mark
 
          */
     }
@@ -50,10 +51,65 @@ void dump_demo(std::string filename)
     }
 }
 
+void sort_demo(std::string filename, std::string out_filename)
+{
+    try
+    {
+        // sort by account then time, using at most about 64MB of memory
+        DBaseTools::Sorter sorter(filename, {"ACCOUNT", "TIME"}, 64ull << 20);
+        sorter.sort_to_dbf(out_filename);
+
+        // or keep the original file and build an ordered index beside it
+        DBaseTools::Sorter time_sorter(filename, {"TIME"});
+        time_sorter.build_index(filename + ".time.idx");
+
+        DBaseTools::OrderedIndex index(filename + ".time.idx");
+        for (auto row : index.range({"093000"}, {"100000"}))
+            std::cout << row << std::endl;
+    }
+    catch (std::runtime_error& e)
+    {
+        std::cout << e.what() << std::endl;
+    }
+}
+
+void aggregate_demo(std::string filename)
+{
+    try
+    {
+        // total quantity and price range per stock code, on all cores
+        DBaseTools::Aggregator aggregator(filename, {"STOCK_CODE"}, {"QTY", "PRICE"}, 0);
+        for (const auto& pr : aggregator.aggregate())
+            std::cout << pr.first[0] << std::endl << pr.second.to_debug_string(aggregator.value_columns) << std::endl;
+    }
+    catch (std::runtime_error& e)
+    {
+        std::cout << e.what() << std::endl;
+    }
+}
+
+void export_demo(std::string filename)
+{
+    try
+    {
+        // convert straight from the file, batches are formatted on all cores and written in order
+        DBaseTools::Exporter exporter(filename, 0);
+        exporter.export_csv(filename + ".csv");
+        exporter.export_json_lines(filename + ".jsonl");
+    }
+    catch (std::runtime_error& e)
+    {
+        std::cout << e.what() << std::endl;
+    }
+}
+
 int main()
 {
     load_demo("D:/WeChat/WeChat Files/wxid_cn79p3oem8dl22/FileStorage/File/2024-07/trade(1).dbf");
 //    dump_demo();
+//    sort_demo("trade.dbf", "trade_sorted.dbf");
+//    aggregate_demo("trade.dbf");
+//    export_demo("trade.dbf");
 //    load_demo("C:/Users/wyw15/Desktop/pingan_pb/export_data/XT_DBF_ORDER.dbf");
 
     return 0;
@@ -4,8 +4,14 @@
 #include <Structures/ColumnDef.hpp>
 #include <Structures/Record.hpp>
 #include <Structures/Table.hpp>
+#include <Structures/SortKey.hpp>
+
+#include <Encoding/CodePage.hpp>
 
 #include <FileOperation/Loader.hpp>
 #include <FileOperation/Dumper.hpp>
+#include <FileOperation/Sorter.hpp>
+#include <FileOperation/Aggregator.hpp>
+#include <FileOperation/Exporter.hpp>
 
 #include <TableBuilder.hpp>
\ No newline at end of file
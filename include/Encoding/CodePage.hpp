@@ -0,0 +1,175 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include "Encoding/GBKTable.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DBASETOOLS_HAS_SSE2 1
+#endif
+
+namespace DBaseTools
+{
+
+// Code page marks stored in byte 29 of the header (language driver id)
+const uint8_t CODE_PAGE_MARK_NONE = 0x00;
+const uint8_t CODE_PAGE_MARK_GBK = 0x7A;        // PRC GBK 936
+const uint8_t CODE_PAGE_MARK_GBK_WINDOWS = 0x4D; // Chinese GBK (PRC) 936, written by some Windows tools
+
+inline bool is_gbk_code_page(uint8_t code_page_mark)
+{
+    return code_page_mark == CODE_PAGE_MARK_GBK || code_page_mark == CODE_PAGE_MARK_GBK_WINDOWS;
+}
+
+// Check whether all bytes are below 0x80, 16 bytes at a time with SSE2, otherwise 8 bytes at a time
+inline bool is_ascii(const char* data, std::size_t size)
+{
+    std::size_t i = 0;
+#ifdef DBASETOOLS_HAS_SSE2
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        if (_mm_movemask_epi8(chunk) != 0)
+            return false;
+    }
+#endif
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t chunk;
+        std::memcpy(&chunk, data + i, 8);
+        if (chunk & 0x8080808080808080ull)
+            return false;
+    }
+    for (; i < size; ++i)
+        if (uint8_t(data[i]) & 0x80)
+            return false;
+    return true;
+}
+
+inline void append_utf8(std::string& out, uint32_t code_point)
+{
+    if (code_point < 0x80)
+        out.push_back(char(code_point));
+    else if (code_point < 0x800)
+    {
+        out.push_back(char(0xC0 | (code_point >> 6)));
+        out.push_back(char(0x80 | (code_point & 0x3F)));
+    }
+    else
+    {
+        out.push_back(char(0xE0 | (code_point >> 12)));
+        out.push_back(char(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back(char(0x80 | (code_point & 0x3F)));
+    }
+}
+
+// Append GBK bytes to out as UTF-8, undefined bytes become U+FFFD
+inline void append_gbk_as_utf8(std::string& out, const char* data, std::size_t size)
+{
+    const uint16_t* table = gbk_to_unicode_table();
+    std::size_t i = 0;
+    while (i < size)
+    {
+        // copy the ASCII run at once
+        std::size_t j = i;
+        while (j < size && !(uint8_t(data[j]) & 0x80)) ++j;
+        out.append(data + i, j - i);
+        if (j == size)
+            break;
+        i = j;
+
+        uint8_t lead = data[i];
+        uint8_t trail = i + 1 < size ? uint8_t(data[i + 1]) : 0;
+        if (lead == 0x80) // single byte euro sign of code page 936
+        {
+            append_utf8(out, 0x20AC);
+            i += 1;
+        }
+        else if (lead <= 0xFE && trail >= 0x40 && trail <= 0xFE && trail != 0x7F)
+        {
+            uint16_t code_point = table[(lead - 0x81) * 190 + (trail - 0x40) - (trail > 0x7F)];
+            append_utf8(out, code_point ? code_point : 0xFFFD);
+            i += 2;
+        }
+        else
+        {
+            append_utf8(out, 0xFFFD);
+            i += 1;
+        }
+    }
+}
+
+// Append bytes to out, keeping well-formed UTF-8 sequences and replacing every other byte >= 0x80 with U+FFFD
+inline void append_valid_utf8(std::string& out, const char* data, std::size_t size)
+{
+    std::size_t i = 0;
+    while (i < size)
+    {
+        uint8_t lead = data[i];
+        if (lead < 0x80)
+        {
+            out.push_back(char(lead));
+            ++i;
+            continue;
+        }
+
+        // sequence length and the range of the second byte, which rules out overlongs and surrogates
+        std::size_t length = 0;
+        uint8_t lo = 0x80, hi = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) length = 2;
+        else if (lead == 0xE0) { length = 3; lo = 0xA0; }
+        else if (lead == 0xED) { length = 3; hi = 0x9F; }
+        else if (lead >= 0xE1 && lead <= 0xEF) length = 3;
+        else if (lead == 0xF0) { length = 4; lo = 0x90; }
+        else if (lead == 0xF4) { length = 4; hi = 0x8F; }
+        else if (lead >= 0xF1 && lead <= 0xF3) length = 4;
+
+        bool valid = length > 0 && i + length <= size;
+        for (std::size_t k = 1; valid && k < length; ++k)
+        {
+            uint8_t ch = data[i + k];
+            valid = k == 1 ? (ch >= lo && ch <= hi) : (ch >= 0x80 && ch <= 0xBF);
+        }
+
+        if (valid)
+        {
+            out.append(data + i, length);
+            i += length;
+        }
+        else
+        {
+            append_utf8(out, 0xFFFD);
+            ++i;
+        }
+    }
+}
+
+inline std::string gbk_to_utf8(const std::string& s)
+{
+    if (is_ascii(s.data(), s.size()))
+        return s;
+
+    std::string ret;
+    ret.reserve(s.size() * 3 / 2);
+    append_gbk_as_utf8(ret, s.data(), s.size());
+    return ret;
+}
+
+// Convert field text in the code page of the file to UTF-8. Only GBK is transcoded, text in other
+// code pages keeps its well-formed UTF-8 sequences and every other byte >= 0x80 becomes U+FFFD,
+// so the result is always valid UTF-8.
+inline std::string to_utf8(const std::string& s, uint8_t code_page_mark)
+{
+    if (is_gbk_code_page(code_page_mark))
+        return gbk_to_utf8(s);
+    if (is_ascii(s.data(), s.size()))
+        return s;
+
+    std::string ret;
+    ret.reserve(s.size());
+    append_valid_utf8(ret, s.data(), s.size());
+    return ret;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
+#include <cstring>
+#include "Structures/Table.hpp"
+#include "Structures/SortKey.hpp"
+#include "FileOperation/Loader.hpp"
+
+namespace DBaseTools
+{
+
+// Aggregated values of one group, values_count/sum/min/max have one entry per value column.
+// count is the number of rows, values_count the number of non-blank values, so the average of
+// column c is sum[c] / values_count[c]. min and max are NaN when a column has no value in the group.
+struct AggregateStats
+{
+    std::string to_debug_string(const std::vector<std::string>& value_columns) const
+    {
+        std::stringstream ss;
+        ss << "count = " << count << std::endl;
+        for (std::size_t i = 0; i < value_columns.size(); ++i)
+            ss << "\"" << value_columns[i] << "\": values_count = " << values_count[i]
+               << ", sum = " << sum[i] << ", min = " << min[i]
+               << ", max = " << max[i] << std::endl;
+        return ss.str();
+    }
+
+    std::size_t count = 0;
+    std::vector<std::size_t> values_count;
+    std::vector<double> sum;
+    std::vector<double> min;
+    std::vector<double> max;
+};
+
+// This class runs group-by count/sum/min/max over numeric columns of a *.dbf file without building
+// Records. The file is read in batches of raw records, each value column is decoded into a
+// contiguous array of doubles and then folded into per-group arrays, groups are found with a hash map.
+// With threads > 1, every thread aggregates its own slice of rows and the results are merged at the end.
+// Deleted records are left out. Blank values are skipped, like the null the Exporter writes for them;
+// values that are not numbers throw. Groups are keyed by the trimmed text of the group columns.
+// For example, to sum quantity and price per stock code on 4 threads:
+//      Aggregator aggregator("trade.dbf", {"STOCK_CODE"}, {"QTY", "PRICE"}, 4);
+//      auto result = aggregator.aggregate();
+//      result[{"600000"}].sum[0]; // total QTY of 600000
+// With no group columns, the result has a single group whose key is empty.
+struct Aggregator
+{
+    Aggregator(const std::string& filename, std::vector<std::string> group_columns,
+        std::vector<std::string> value_columns, std::size_t threads = 1, std::size_t batch_rows = 1 << 16)
+        : filename(filename), group_columns(std::move(group_columns)), value_columns(std::move(value_columns)),
+          threads(threads), batch_rows(std::max<std::size_t>(1, batch_rows))
+    {
+        schema = Loader(filename).load_schema();
+
+        if (!this->group_columns.empty())
+            group_key = SortKey(schema, this->group_columns, false);
+
+        auto offsets = schema->field_offsets();
+        for (const auto& field_name : this->value_columns)
+        {
+            std::size_t column_index = schema->column_index(field_name);
+            value_offsets.push_back(offsets[column_index]);
+            value_lengths.push_back(schema->col_defs[column_index]->field_length);
+        }
+
+        if (this->threads == 0)
+            this->threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::map<std::vector<std::string>, AggregateStats> aggregate()
+    {
+        std::size_t records_cnt = schema->header->records_cnt;
+        std::size_t workers_cnt = std::max<std::size_t>(1, std::min(threads, records_cnt / batch_rows + 1));
+
+        std::vector<Partial> partials(workers_cnt);
+        if (workers_cnt == 1)
+            aggregate_rows(0, records_cnt, partials[0]);
+        else
+        {
+            std::vector<std::exception_ptr> errors(workers_cnt);
+            std::vector<std::thread> workers;
+            for (std::size_t i = 0; i < workers_cnt; ++i)
+                workers.emplace_back([&, i]()
+                {
+                    try
+                    {
+                        aggregate_rows(records_cnt * i / workers_cnt, records_cnt * (i + 1) / workers_cnt, partials[i]);
+                    }
+                    catch (...)
+                    {
+                        errors[i] = std::current_exception();
+                    }
+                });
+            for (auto& worker : workers)
+                worker.join();
+            for (auto& error : errors)
+                if (error)
+                    std::rethrow_exception(error);
+        }
+
+        std::map<std::vector<std::string>, AggregateStats> result;
+        for (const auto& partial : partials)
+        {
+            for (std::size_t g = 0; g < partial.group_keys.size(); ++g)
+            {
+                auto it = result.find(split_group_key(partial.group_keys[g]));
+                if (it == result.end())
+                {
+                    AggregateStats stats;
+                    stats.values_count.assign(value_columns.size(), 0);
+                    stats.sum.assign(value_columns.size(), 0);
+                    stats.min.assign(value_columns.size(), std::numeric_limits<double>::infinity());
+                    stats.max.assign(value_columns.size(), -std::numeric_limits<double>::infinity());
+                    it = result.emplace(split_group_key(partial.group_keys[g]), std::move(stats)).first;
+                }
+
+                auto& stats = it->second;
+                stats.count += partial.counts[g];
+                for (std::size_t c = 0; c < value_columns.size(); ++c)
+                {
+                    stats.values_count[c] += partial.values_counts[c][g];
+                    stats.sum[c] += partial.sums[c][g];
+                    stats.min[c] = std::min(stats.min[c], partial.mins[c][g]);
+                    stats.max[c] = std::max(stats.max[c], partial.maxs[c][g]);
+                }
+            }
+        }
+
+        for (auto& pr : result)
+            for (std::size_t c = 0; c < value_columns.size(); ++c)
+                if (pr.second.values_count[c] == 0)
+                    pr.second.min[c] = pr.second.max[c] = std::numeric_limits<double>::quiet_NaN();
+        return result;
+    }
+
+    // Decode a fixed-width decimal field such as "  -12.50" or "1.5E+03", return false if it is not a number.
+    // A blank field gives NaN, which the folds below skip.
+    static bool parse_number(const char* field, std::size_t length, double& value)
+    {
+        std::size_t l = 0, r = length;
+        trim_field(field, l, r);
+        value = std::numeric_limits<double>::quiet_NaN();
+        if (l == r)
+            return true;
+
+        NumberText number;
+        if (!scan_number(field + l, r - l, number))
+            return false;
+
+        // the mantissa may overflow or need scaling, leave it to strtod
+        if (number.int_size + number.frac_size > 18 || number.exponent != 0)
+        {
+            value = std::strtod(std::string(field + l, r - l).c_str(), nullptr);
+            return true;
+        }
+
+        static const double pow10[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+            1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+        };
+        uint64_t mantissa = 0;
+        for (std::size_t i = 0; i < number.int_size; ++i)
+            mantissa = mantissa * 10 + (number.int_digits[i] - '0');
+        for (std::size_t i = 0; i < number.frac_size; ++i)
+            mantissa = mantissa * 10 + (number.frac_digits[i] - '0');
+        value = mantissa / pow10[number.frac_size];
+        if (number.negative)
+            value = -value;
+        return true;
+    }
+
+    std::string filename;
+    std::vector<std::string> group_columns;
+    std::vector<std::string> value_columns;
+    std::size_t threads;
+    std::size_t batch_rows;
+    std::shared_ptr<Table> schema;
+
+private:
+
+    // Aggregates of one worker, arrays are indexed by group id, sums/mins/maxs by value column first
+    struct Partial
+    {
+        std::unordered_map<std::string, uint32_t> group_ids;
+        std::vector<std::string> group_keys;
+        std::vector<std::size_t> counts;
+        std::vector<std::vector<std::size_t>> values_counts;
+        std::vector<std::vector<double>> sums;
+        std::vector<std::vector<double>> mins;
+        std::vector<std::vector<double>> maxs;
+    };
+
+    void aggregate_rows(std::size_t row_begin, std::size_t row_end, Partial& partial)
+    {
+        Loader loader(filename);
+        std::size_t record_size = schema->header->bytes_per_record;
+
+        partial.values_counts.resize(value_columns.size());
+        partial.sums.resize(value_columns.size());
+        partial.mins.resize(value_columns.size());
+        partial.maxs.resize(value_columns.size());
+        if (group_columns.empty())
+            add_group(partial, "");
+
+        std::string raw;
+        std::string key(group_key.length, '\0');
+        std::string last_key;
+        uint32_t last_group = 0;
+        std::vector<std::size_t> rows;
+        std::vector<uint32_t> groups;
+        std::vector<double> values;
+        for (std::size_t batch_begin = row_begin; batch_begin < row_end; batch_begin += batch_rows)
+        {
+            std::size_t rows_cnt = std::min(batch_rows, row_end - batch_begin);
+            loader.load_raw_records(schema, batch_begin, rows_cnt, raw);
+
+            // rows of the batch that are not deleted
+            rows.clear();
+            for (std::size_t i = 0; i < rows_cnt; ++i)
+                if (raw[i * record_size] != '*')
+                    rows.push_back(i);
+
+            // group id of every row, consecutive rows often share a key so the last lookup is reused
+            groups.assign(rows.size(), 0);
+            if (!group_columns.empty())
+            {
+                for (std::size_t i = 0; i < rows.size(); ++i)
+                {
+                    group_key.extract(raw.data() + rows[i] * record_size, &key[0]);
+                    if (key != last_key)
+                    {
+                        auto it = partial.group_ids.find(key);
+                        last_group = it != partial.group_ids.end() ? it->second : add_group(partial, key);
+                        last_key = key;
+                    }
+                    groups[i] = last_group;
+                }
+            }
+            for (std::size_t i = 0; i < rows.size(); ++i)
+                ++partial.counts[groups[i]];
+
+            values.resize(rows.size());
+            for (std::size_t c = 0; c < value_columns.size(); ++c)
+            {
+                for (std::size_t i = 0; i < rows.size(); ++i)
+                    if (!parse_number(raw.data() + rows[i] * record_size + value_offsets[c], value_lengths[c], values[i]))
+                        throw std::runtime_error(
+                            "Value of field [" + value_columns[c] + "] is not a number, row = " +
+                                std::to_string(batch_begin + rows[i]) + ", value = \"" +
+                                trim(raw.substr(rows[i] * record_size + value_offsets[c], value_lengths[c])) + "\""
+                        );
+
+                if (group_columns.empty())
+                    fold_all(values, partial.values_counts[c][0], partial.sums[c][0], partial.mins[c][0],
+                        partial.maxs[c][0]);
+                else
+                    fold_groups(values, groups, partial.values_counts[c], partial.sums[c], partial.mins[c],
+                        partial.maxs[c]);
+            }
+        }
+    }
+
+    uint32_t add_group(Partial& partial, const std::string& key)
+    {
+        uint32_t group = partial.group_keys.size();
+        partial.group_ids.emplace(key, group);
+        partial.group_keys.push_back(key);
+        partial.counts.push_back(0);
+        for (std::size_t c = 0; c < value_columns.size(); ++c)
+        {
+            partial.values_counts[c].push_back(0);
+            partial.sums[c].push_back(0);
+            partial.mins[c].push_back(std::numeric_limits<double>::infinity());
+            partial.maxs[c].push_back(-std::numeric_limits<double>::infinity());
+        }
+        return group;
+    }
+
+    // Plain reductions over the whole batch, 4 independent lanes so the compiler can keep them in vector registers.
+    // Blank values are NaN: v == v is false for them, and std::min/std::max keep their first argument against NaN.
+    static void fold_all(const std::vector<double>& values, std::size_t& values_count, double& sum,
+        double& min, double& max)
+    {
+        std::size_t cnt[4] = {0, 0, 0, 0};
+        double s[4] = {0, 0, 0, 0};
+        double lo[4] = {min, min, min, min};
+        double hi[4] = {max, max, max, max};
+        std::size_t n = values.size(), i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            for (std::size_t k = 0; k < 4; ++k)
+            {
+                double v = values[i + k];
+                cnt[k] += v == v;
+                s[k] += v == v ? v : 0;
+                lo[k] = std::min(lo[k], v);
+                hi[k] = std::max(hi[k], v);
+            }
+        }
+        for (; i < n; ++i)
+        {
+            double v = values[i];
+            cnt[0] += v == v;
+            s[0] += v == v ? v : 0;
+            lo[0] = std::min(lo[0], v);
+            hi[0] = std::max(hi[0], v);
+        }
+        values_count += (cnt[0] + cnt[1]) + (cnt[2] + cnt[3]);
+        sum += (s[0] + s[1]) + (s[2] + s[3]);
+        min = std::min(std::min(lo[0], lo[1]), std::min(lo[2], lo[3]));
+        max = std::max(std::max(hi[0], hi[1]), std::max(hi[2], hi[3]));
+    }
+
+    static void fold_groups(const std::vector<double>& values, const std::vector<uint32_t>& groups,
+        std::vector<std::size_t>& values_counts, std::vector<double>& sums,
+        std::vector<double>& mins, std::vector<double>& maxs)
+    {
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            uint32_t g = groups[i];
+            double v = values[i];
+            values_counts[g] += v == v;
+            sums[g] += v == v ? v : 0;
+            mins[g] = std::min(mins[g], v);
+            maxs[g] = std::max(maxs[g], v);
+        }
+    }
+
+    std::vector<std::string> split_group_key(const std::string& key) const
+    {
+        std::vector<std::string> values;
+        std::size_t cur_pos = 0;
+        for (auto field_length : group_key.field_lengths)
+        {
+            values.push_back(std::string(key.substr(cur_pos, field_length).c_str()));
+            cur_pos += field_length;
+        }
+        return values;
+    }
+
+    SortKey group_key;
+    std::vector<std::size_t> value_offsets;
+    std::vector<std::size_t> value_lengths;
+};
+
+}
\ No newline at end of file
@@ -58,6 +58,36 @@ struct Dumper
         dump_file_terminator();
     }
 
+    // Write header, column definitions and terminator only, records are written by dump_raw_records
+    void dump_schema(std::shared_ptr<const Table> table)
+    {
+        dump_header(table->header);
+
+        for (std::size_t i = 0; i < table->col_defs.size(); ++i)
+            dump_column_def(table->col_defs[i], 32 + i * 32);
+        fout.seekp(32 + table->col_defs.size() * 32, std::ios::beg);
+        fout.write("\x0D", 1); // terminator
+    }
+
+    // Write already encoded records, as returned by Loader::load_raw_records, starting at row_begin
+    void dump_raw_records(std::shared_ptr<const Table> table, std::size_t row_begin, const std::string& data)
+    {
+        if (data.size() % table->header->bytes_per_record != 0)
+            throw std::runtime_error(
+                "Invalid raw records, data.size() = " + std::to_string(data.size()) +
+                    ", bytes_per_record = " + std::to_string(table->header->bytes_per_record)
+            );
+
+        fout.seekp(32 + table->col_defs.size() * 32 + 1 + row_begin * table->header->bytes_per_record, std::ios::beg);
+        fout.write(data.data(), data.size());
+    }
+
+    void dump_file_terminator()
+    {
+        fout.seekp(0, std::ios::end);
+        fout.write("\x1A", 1);
+    }
+
     void flush()
     {
         fout.flush();
@@ -97,11 +127,6 @@ private:
         fout.write(record_data.data(), record_data.size());
     }
 
-    void dump_file_terminator()
-    {
-        fout.seekp(0, std::ios::end);
-        fout.write("\x1A", 1);
-    }
 };
 
 }
\ No newline at end of file
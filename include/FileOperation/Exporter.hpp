@@ -0,0 +1,350 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <fstream>
+#include <future>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include "Structures/Table.hpp"
+#include "Encoding/CodePage.hpp"
+#include "FileOperation/Loader.hpp"
+
+namespace DBaseTools
+{
+
+// This class converts a *.dbf file to CSV or JSON Lines without building Records.
+// Raw records are read in batches, each batch is formatted straight into one large output
+// buffer and written in file order, so memory stays bounded by threads * batch_rows records.
+// With threads > 1, the next batches are formatted on other threads while the current one is written.
+// Deleted records are left out. Values and column names are trimmed and GBK text is transcoded to UTF-8.
+// Other code pages are not transcoded: text that is already well-formed UTF-8 is kept, every other
+// byte >= 0x80 becomes U+FFFD, so the output is always valid UTF-8. Fields are formatted by their type:
+// 'N'/'F' as numbers, 'L' as true/false, 'D' as YYYY-MM-DD, blank non-text values as null.
+// For example:
+//      Exporter exporter("trade.dbf", 4);
+//      exporter.export_csv("trade.csv");
+//      exporter.export_json_lines("trade.jsonl");
+struct Exporter
+{
+    Exporter(const std::string& filename, std::size_t threads = 1, std::size_t batch_rows = 1 << 16)
+        : filename(filename), threads(threads), batch_rows(std::max<std::size_t>(1, batch_rows))
+    {
+        schema = Loader(filename).load_schema();
+        field_offsets = schema->field_offsets();
+
+        if (this->threads == 0)
+            this->threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Write one line per record, the first line holds the column names if with_header
+    void export_csv(const std::string& out_filename, char sep = ',', bool with_header = true)
+    {
+        std::string head;
+        if (with_header)
+        {
+            for (std::size_t c = 0; c < schema->col_defs.size(); ++c)
+            {
+                if (c > 0)
+                    head.push_back(sep);
+                std::string field_name = field_name_utf8(c);
+                append_csv_string(head, field_name.data(), field_name.size(), sep);
+            }
+            head.push_back('\n');
+        }
+
+        export_rows(out_filename, head, [this, sep](const std::string& raw, std::size_t rows_cnt, std::string& out)
+        {
+            std::string scratch;
+            for (std::size_t i = 0; i < rows_cnt; ++i)
+            {
+                const char* record = raw.data() + i * schema->header->bytes_per_record;
+                if (record[0] == '*') // deleted
+                    continue;
+                for (std::size_t c = 0; c < schema->col_defs.size(); ++c)
+                {
+                    if (c > 0)
+                        out.push_back(sep);
+
+                    const char* value;
+                    std::size_t size;
+                    switch (format_field(c, record, scratch, value, size))
+                    {
+                    case ValueKind::Null:
+                        break;
+                    case ValueKind::String:
+                        append_csv_string(out, value, size, sep);
+                        break;
+                    default:
+                        out.append(value, size);
+                        break;
+                    }
+                }
+                out.push_back('\n');
+            }
+        });
+    }
+
+    // Write one JSON object per record and per line, keyed by column name
+    void export_json_lines(const std::string& out_filename)
+    {
+        // "{\"NAME\":" for the first column, ",\"AGE\":" for the others
+        std::vector<std::string> keys;
+        for (std::size_t c = 0; c < schema->col_defs.size(); ++c)
+        {
+            std::string field_name = field_name_utf8(c);
+            std::string key = c == 0 ? "{" : ",";
+            append_json_string(key, field_name.data(), field_name.size());
+            key.push_back(':');
+            keys.push_back(std::move(key));
+        }
+
+        export_rows(out_filename, "", [this, keys](const std::string& raw, std::size_t rows_cnt, std::string& out)
+        {
+            std::string scratch;
+            for (std::size_t i = 0; i < rows_cnt; ++i)
+            {
+                const char* record = raw.data() + i * schema->header->bytes_per_record;
+                if (record[0] == '*') // deleted
+                    continue;
+                if (keys.empty())
+                    out.push_back('{');
+                for (std::size_t c = 0; c < schema->col_defs.size(); ++c)
+                {
+                    out.append(keys[c]);
+
+                    const char* value;
+                    std::size_t size;
+                    switch (format_field(c, record, scratch, value, size))
+                    {
+                    case ValueKind::Null:
+                        out.append("null");
+                        break;
+                    case ValueKind::String:
+                        append_json_string(out, value, size);
+                        break;
+                    default:
+                        out.append(value, size);
+                        break;
+                    }
+                }
+                out.append("}\n");
+            }
+        });
+    }
+
+    std::string filename;
+    std::size_t threads;
+    std::size_t batch_rows;
+    std::shared_ptr<Table> schema;
+
+private:
+
+    enum class ValueKind { Null, String, Number, Boolean };
+
+    // Format batch rows [0, rows_cnt) of raw into out
+    typedef std::function<void(const std::string& raw, std::size_t rows_cnt, std::string& out)> FormatBatch;
+
+    void export_rows(const std::string& out_filename, const std::string& head, const FormatBatch& format_batch)
+    {
+        std::ofstream fout(out_filename, std::ios::binary);
+        if (!fout)
+            throw std::runtime_error("Cannot open file " + out_filename);
+        fout.write(head.data(), head.size());
+
+        // one loader per thread, batch k always uses loaders[k % threads],
+        // batch k + threads is only started after batch k has been written
+        std::vector<std::unique_ptr<Loader>> loaders;
+        for (std::size_t i = 0; i < threads; ++i)
+            loaders.emplace_back(new Loader(filename));
+
+        std::size_t records_cnt = schema->header->records_cnt;
+        std::size_t batches_cnt = (records_cnt + batch_rows - 1) / batch_rows;
+        auto run_batch = [&](std::size_t batch)
+        {
+            std::size_t row_begin = batch * batch_rows;
+            std::size_t rows_cnt = std::min(batch_rows, records_cnt - row_begin);
+            std::string raw, out;
+            loaders[batch % threads]->load_raw_records(schema, row_begin, rows_cnt, raw);
+            out.reserve(raw.size() + raw.size() / 2);
+            format_batch(raw, rows_cnt, out);
+            return out;
+        };
+
+        std::deque<std::future<std::string>> pending;
+        std::size_t next_batch = 0;
+        while (next_batch < batches_cnt || !pending.empty())
+        {
+            while (next_batch < batches_cnt && pending.size() < threads)
+                pending.push_back(std::async(threads > 1 ? std::launch::async : std::launch::deferred,
+                    run_batch, next_batch++));
+
+            std::string out = pending.front().get();
+            pending.pop_front();
+            fout.write(out.data(), out.size());
+            if (!fout)
+                throw std::runtime_error("Cannot write file " + out_filename);
+        }
+        fout.flush();
+    }
+
+    std::string field_name_utf8(std::size_t c) const
+    {
+        return to_utf8(schema->col_defs[c]->field_name, schema->header->code_page_mark);
+    }
+
+    // Locate the value of column c in record and classify it by the column type. value points into
+    // record, into a static literal, or into scratch when the text has been transcoded or normalized.
+    ValueKind format_field(std::size_t c, const char* record, std::string& scratch,
+        const char*& value, std::size_t& size) const
+    {
+        const char* field = record + field_offsets[c];
+        std::size_t l = 0, r = schema->col_defs[c]->field_length;
+        trim_field(field, l, r);
+        value = field + l;
+        size = r - l;
+
+        switch (schema->col_defs[c]->field_type)
+        {
+        case 'N':
+        case 'F':
+            if (size == 0)
+                return ValueKind::Null;
+            if (normalize_number(value, size, scratch))
+            {
+                value = scratch.data();
+                size = scratch.size();
+                return ValueKind::Number;
+            }
+            break;
+        case 'L':
+            if (size == 1 && (*value == 'T' || *value == 't' || *value == 'Y' || *value == 'y'))
+            {
+                value = "true";
+                size = 4;
+                return ValueKind::Boolean;
+            }
+            if (size == 1 && (*value == 'F' || *value == 'f' || *value == 'N' || *value == 'n'))
+            {
+                value = "false";
+                size = 5;
+                return ValueKind::Boolean;
+            }
+            if (size == 0 || (size == 1 && *value == '?'))
+                return ValueKind::Null;
+            break;
+        case 'D':
+            if (size == 0)
+                return ValueKind::Null;
+            if (size == 8 && std::all_of(value, value + 8, [](char ch) { return ch >= '0' && ch <= '9'; }))
+            {
+                scratch.assign(value, 4).append("-").append(value + 4, 2).append("-").append(value + 6, 2);
+                value = scratch.data();
+                size = scratch.size();
+                return ValueKind::String;
+            }
+            break;
+        default:
+            break;
+        }
+
+        if (!is_ascii(value, size))
+        {
+            scratch.clear();
+            if (is_gbk_code_page(schema->header->code_page_mark))
+                append_gbk_as_utf8(scratch, value, size);
+            else
+                append_valid_utf8(scratch, value, size);
+            value = scratch.data();
+            size = scratch.size();
+        }
+        return ValueKind::String;
+    }
+
+    // Rewrite a decimal such as "+007.50", "-.5" or "1.5E+03" as a JSON number ("7.50", "-0.5", "1.5E+03"),
+    // false if it is not one
+    static bool normalize_number(const char* value, std::size_t size, std::string& out)
+    {
+        NumberText number;
+        if (!scan_number(value, size, number))
+            return false;
+
+        const char* int_begin = number.int_digits;
+        std::size_t int_size = number.int_size;
+        while (int_size > 1 && *int_begin == '0') ++int_begin, --int_size;
+
+        out.clear();
+        if (number.negative)
+            out.push_back('-');
+        if (int_size == 0)
+            out.push_back('0');
+        else
+            out.append(int_begin, int_size);
+        if (number.frac_size > 0)
+            out.append(".").append(number.frac_digits, number.frac_size);
+
+        // the exponent, if any, is already valid JSON
+        const char* exponent = number.frac_digits + number.frac_size;
+        out.append(exponent, value + size - exponent);
+        return true;
+    }
+
+    static void append_csv_string(std::string& out, const char* value, std::size_t size, char sep)
+    {
+        bool need_quote = false;
+        for (std::size_t i = 0; i < size && !need_quote; ++i)
+            need_quote = value[i] == sep || value[i] == '"' || value[i] == '\n' || value[i] == '\r';
+        if (!need_quote)
+        {
+            out.append(value, size);
+            return;
+        }
+
+        out.push_back('"');
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            if (value[i] == '"')
+                out.push_back('"');
+            out.push_back(value[i]);
+        }
+        out.push_back('"');
+    }
+
+    static void append_json_string(std::string& out, const char* value, std::size_t size)
+    {
+        static const char hex[] = "0123456789abcdef";
+        out.push_back('"');
+        std::size_t begin = 0;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            uint8_t ch = value[i];
+            if (ch >= 0x20 && ch != '"' && ch != '\\')
+                continue;
+
+            out.append(value + begin, i - begin);
+            begin = i + 1;
+            switch (ch)
+            {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                out.append("\\u00");
+                out.push_back(hex[ch >> 4]);
+                out.push_back(hex[ch & 0xF]);
+                break;
+            }
+        }
+        out.append(value + begin, size - begin);
+        out.push_back('"');
+    }
+
+    std::vector<std::size_t> field_offsets;
+};
+
+}
\ No newline at end of file
@@ -28,28 +28,71 @@ struct Loader
     // Load a table from file
     std::shared_ptr<Table> load_table()
     {
-        std::size_t file_size = get_file_size();
+        auto table = load_schema();
+
+        // record_size = deleted_flag(1) + sum(column_def->field_length)
+        std::vector<std::shared_ptr<Record>> records;
+        for (std::size_t i = 0; i < table->header->records_cnt; ++i)
+            records.push_back(load_record(table->col_defs, *table->header, i));
+
+        table->records = std::move(records);
+        return table;
+    }
 
+    // Load header and column definitions only, records are left in the file
+    std::shared_ptr<Table> load_schema()
+    {
         auto header = load_header();
 
-        // header->header_total_bytes = 32 + columns_count * column_def_size(32) + terminator(1)
+        // header->header_total_bytes = 32 + columns_count * column_def_size(32) + terminator(1),
+        // some writers put more bytes before the records, so the column definitions also end at the terminator
         std::size_t columns_cnt = (header->header_total_bytes - 32 - 1) / 32;
         std::vector<std::shared_ptr<ColumnDef>> col_defs;
         for (std::size_t i = 0; i < columns_cnt; ++i)
-            col_defs.push_back(load_column_def(i));
-
-        // record_size = deleted_flag(1) + sum(column_def->field_length)
-        std::vector<std::shared_ptr<Record>> records;
-        for (std::size_t i = 0; i < header->records_cnt; ++i)
-            records.push_back(load_record(col_defs, header->bytes_per_record, i));
+        {
+            auto col_def = load_column_def(i);
+            if (!col_def)
+                break;
+            col_defs.push_back(std::move(col_def));
+        }
 
         auto table = std::make_shared<Table>();
         table->header = std::move(header);
         table->col_defs = std::move(col_defs);
-        table->records = std::move(records);
         return table;
     }
 
+    // Load raw bytes of records [row_begin, row_begin + rows_cnt) into buf without parsing them.
+    // Record i starts at buf[i * bytes_per_record] with its deleted flag ('*' means deleted),
+    // its fields are at schema->field_offsets().
+    void load_raw_records(std::shared_ptr<const Table> schema, std::size_t row_begin, std::size_t rows_cnt,
+        std::string& buf)
+    {
+        std::size_t record_size = schema->header->bytes_per_record;
+        std::size_t fields_end = 1; // deleted flag(1) + sum(column_def->field_length)
+        for (const auto& col_def : schema->col_defs)
+            fields_end += col_def->field_length;
+        if (fields_end > record_size)
+            throw std::runtime_error(
+                "Column definitions do not fit in a record, need = " + std::to_string(fields_end) +
+                    ", bytes_per_record = " + std::to_string(record_size)
+            );
+
+        // offset = header_total_bytes + row_begin * record_size
+        std::size_t offset = schema->header->header_total_bytes + row_begin * record_size;
+        if (offset + rows_cnt * record_size > get_file_size())
+            throw std::runtime_error(
+                "File is too small to contain records, need = " + std::to_string(offset + rows_cnt * record_size) +
+                    ", file_size = " + std::to_string(get_file_size())
+            );
+
+        buf.resize(rows_cnt * record_size);
+        if (buf.empty())
+            return;
+        fin.seekg(offset, fin.beg);
+        fin.read(&buf.at(0), buf.size());
+    }
+
     // Incrementally update a table from file, return old and new records count
     std::tuple<std::size_t, std::size_t> update_table(std::shared_ptr<Table> table)
     {
@@ -64,7 +107,7 @@ struct Loader
 
         std::vector<std::shared_ptr<Record>> new_records;
         for (std::size_t i = old_records_cnt; i < new_records_cnt; ++i)
-            new_records.push_back(load_record(table->col_defs, table->records[0]->contents.size(), i));
+            new_records.push_back(load_record(table->col_defs, *header, i));
 
         table->header = std::move(header);
         table->records.insert(table->records.end(), new_records.begin(), new_records.end());
@@ -97,6 +140,7 @@ private:
         return header;
     }
 
+    // Return nullptr if the terminator(0x0D) is found instead of a column definition
     std::shared_ptr<ColumnDef> load_column_def(std::size_t column_index)
     {
         std::size_t offset = 32 + column_index * 32; // offset = header(32) + column_index * column_def_size(32)
@@ -109,18 +153,21 @@ private:
         std::string buf(32, '\0');
         fin.seekg(offset, fin.beg);
         fin.read(&buf.at(0), 32);
+        if (buf.at(0) == 0x0D)
+            return nullptr;
         auto column_def = std::make_shared<ColumnDef>();
         column_def->from_binary(buf);
 
         return column_def;
     }
 
-    std::shared_ptr<Record> load_record(std::vector<std::shared_ptr<ColumnDef>> col_defs,
-        size_t record_size,
+    std::shared_ptr<Record> load_record(const std::vector<std::shared_ptr<ColumnDef>>& col_defs,
+        const Header& header,
         std::size_t record_index)
     {
-        // offset = header(32) + columns_count * column_def_size(32) + record_index * record_size
-        std::size_t offset = 32 + col_defs.size() * 32 + record_index * record_size;
+        // offset = header_total_bytes + record_index * record_size
+        std::size_t record_size = header.bytes_per_record;
+        std::size_t offset = header.header_total_bytes + record_index * record_size;
         if (offset + record_size > get_file_size())
             throw std::runtime_error(
                 "File is too small to contain record, need = " + std::to_string(offset + record_size) +
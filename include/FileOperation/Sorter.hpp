@@ -0,0 +1,446 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <functional>
+#include <cstring>
+#include <cstdio>
+#include "Structures/Table.hpp"
+#include "Structures/SortKey.hpp"
+#include "FileOperation/Loader.hpp"
+#include "FileOperation/Dumper.hpp"
+
+namespace DBaseTools
+{
+
+// This class sorts the records of a *.dbf file on one or more columns in bounded memory,
+// so it works for files larger than RAM. Records are cut into sorted runs of about memory_limit
+// bytes, the runs are spilled to temporary files next to the output and then merged.
+// The sort is stable: records with equal keys keep their order in the file. Deleted records are left out.
+// If you want a new sorted dbf file, you can do like this:
+//      Sorter sorter("trade.dbf", {"ACCOUNT", "TIME"});
+//      sorter.sort_to_dbf("trade_sorted.dbf");
+// If you want an ordered row index beside the original file, you can do like this:
+//      Sorter sorter("trade.dbf", {"TIME"});
+//      sorter.build_index("trade.time.idx");
+//      OrderedIndex index("trade.time.idx");
+//      auto rows = index.range({"093000"}, {"100000"});
+struct Sorter
+{
+    Sorter(const std::string& filename, const std::vector<std::string>& key_columns,
+        std::size_t memory_limit = 64ull << 20)
+        : loader(filename), schema(loader.load_schema()), key(schema, key_columns), memory_limit(memory_limit)
+    {
+    }
+
+    // Write all records ordered by key into a new dbf file
+    void sort_to_dbf(const std::string& out_filename)
+    {
+        std::size_t record_size = schema->header->bytes_per_record;
+        std::size_t entry_size = key.length + record_size;
+        RunFiles run_files(out_filename);
+        auto runs = make_runs(run_files, true);
+
+        // records are written at 32 + columns_count * 32 + 1 by Dumper, keep the header consistent with it
+        auto out_schema = std::make_shared<Table>(*schema);
+        out_schema->header = std::make_shared<Header>(*schema->header);
+        out_schema->header->header_total_bytes = 32 + schema->col_defs.size() * 32 + 1;
+
+        Dumper dumper(out_filename);
+        dumper.dump_schema(out_schema);
+
+        // the output buffer is taken out of the budget of the run readers
+        std::string buf;
+        std::size_t buf_limit = std::max(record_size, std::min<std::size_t>(memory_limit / 4, 4ull << 20));
+        std::size_t row = 0;
+        merge_runs(runs, run_files, entry_size, memory_limit - std::min(memory_limit, buf_limit), [&](const char* entry)
+        {
+            buf.append(entry + key.length, record_size);
+            if (buf.size() >= buf_limit)
+            {
+                dumper.dump_raw_records(out_schema, row, buf);
+                row += buf.size() / record_size;
+                buf.clear();
+            }
+        });
+        dumper.dump_raw_records(out_schema, row, buf);
+        row += buf.size() / record_size;
+
+        // deleted records were left out
+        out_schema->header->records_cnt = row;
+        dumper.dump_schema(out_schema);
+        dumper.dump_file_terminator();
+        dumper.flush();
+    }
+
+    // Write an ordered row index file, see OrderedIndex for its layout
+    void build_index(const std::string& index_filename)
+    {
+        std::size_t entry_size = key.length + 4;
+        RunFiles run_files(index_filename);
+        auto runs = make_runs(run_files, false);
+
+        std::ofstream fout(index_filename, std::ios::binary);
+        if (!fout)
+            throw std::runtime_error("Cannot open file " + index_filename);
+
+        std::string index_header(24 + key.field_lengths.size() * 16, '\0');
+        index_header.replace(0, 8, "DBFIDX02", 8);
+        write_le(&index_header[8], key.field_lengths.size(), 4);
+        write_le(&index_header[12], key.length, 4);
+        write_le(&index_header[16], schema->header->records_cnt, 8);
+        for (std::size_t i = 0; i < key.field_lengths.size(); ++i)
+        {
+            index_header.replace(24 + i * 16, key.field_names[i].size(), key.field_names[i]);
+            index_header[24 + i * 16 + 11] = uint8_t(key.field_lengths[i]);
+            index_header[24 + i * 16 + 12] = key.field_types[i];
+        }
+        fout.write(index_header.data(), index_header.size());
+
+        uint64_t entries_cnt = 0;
+        merge_runs(runs, run_files, entry_size, memory_limit, [&](const char* entry)
+        {
+            fout.write(entry, entry_size);
+            ++entries_cnt;
+        });
+
+        // deleted records were left out
+        write_le(&index_header[16], entries_cnt, 8);
+        fout.seekp(16, std::ios::beg);
+        fout.write(&index_header[16], 8);
+        fout.flush();
+    }
+
+    Loader loader;
+    std::shared_ptr<Table> schema;
+    SortKey key;
+    std::size_t memory_limit;
+
+private:
+
+    // Buffered reader over one run file
+    struct RunReader
+    {
+        RunReader(const std::string& filename, std::size_t entry_size, std::size_t buf_size)
+            : fin(filename, std::ios::binary), entry_size(entry_size),
+              buf(std::max(entry_size, buf_size / entry_size * entry_size), '\0')
+        {
+            if (!fin)
+                throw std::runtime_error("Cannot open file " + filename);
+            fill();
+        }
+
+        bool empty() const { return pos >= end; }
+        const char* current() const { return buf.data() + pos; }
+
+        void advance()
+        {
+            pos += entry_size;
+            if (pos >= end)
+                fill();
+        }
+
+        std::ifstream fin;
+        std::size_t entry_size;
+        std::string buf;
+        std::size_t pos = 0;
+        std::size_t end = 0;
+
+    private:
+        void fill()
+        {
+            fin.read(&buf.at(0), buf.size());
+            pos = 0;
+            end = fin.gcount() / entry_size * entry_size;
+        }
+    };
+
+    static void write_le(char* dst, uint64_t value, std::size_t bytes)
+    {
+        for (std::size_t i = 0; i < bytes; ++i)
+            dst[i] = char((value >> (8 * i)) & 0xFF);
+    }
+
+    // Names the temporary run files prefix.run0, prefix.run1, ... and removes all of them when it goes out
+    // of scope, so no run file is left behind when sorting stops on an exception
+    struct RunFiles
+    {
+        RunFiles(const std::string& prefix) : prefix(prefix) {}
+        RunFiles(const RunFiles&) = delete;
+        RunFiles& operator=(const RunFiles&) = delete;
+
+        ~RunFiles()
+        {
+            for (const auto& name : names)
+                std::remove(name.c_str());
+        }
+
+        const std::string& next()
+        {
+            names.push_back(prefix + ".run" + std::to_string(names.size()));
+            return names.back();
+        }
+
+        std::string prefix;
+        std::vector<std::string> names;
+    };
+
+    // Cut the record region into sorted runs, each entry is key + record (keep_records) or key + row number
+    std::vector<std::string> make_runs(RunFiles& run_files, bool keep_records)
+    {
+        std::size_t records_cnt = schema->header->records_cnt;
+        std::size_t record_size = schema->header->bytes_per_record;
+        std::size_t payload_size = keep_records ? record_size : 4;
+        std::size_t entry_size = key.length + payload_size;
+
+        // the raw chunk, its entries and the order vector share the memory budget
+        std::size_t rows_per_run = std::max<std::size_t>(1, memory_limit / (record_size + entry_size + sizeof(uint32_t)));
+
+        std::vector<std::string> runs;
+        std::string raw, entries;
+        std::vector<uint32_t> order;
+        for (std::size_t row_begin = 0; row_begin < records_cnt; row_begin += rows_per_run)
+        {
+            std::size_t rows_cnt = std::min(rows_per_run, records_cnt - row_begin);
+            loader.load_raw_records(schema, row_begin, rows_cnt, raw);
+
+            entries.resize(rows_cnt * entry_size);
+            std::size_t entries_cnt = 0;
+            for (std::size_t i = 0; i < rows_cnt; ++i)
+            {
+                const char* record = raw.data() + i * record_size;
+                if (record[0] == '*') // deleted
+                    continue;
+                char* entry = &entries[entries_cnt++ * entry_size];
+                key.extract(record, entry);
+                if (keep_records)
+                    std::memcpy(entry + key.length, record, record_size);
+                else
+                    write_le(entry + key.length, row_begin + i, 4);
+            }
+
+            order.resize(entries_cnt);
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+            {
+                return std::memcmp(&entries[a * entry_size], &entries[b * entry_size], key.length) < 0;
+            });
+
+            runs.push_back(run_files.next());
+            std::ofstream fout(runs.back(), std::ios::binary);
+            if (!fout)
+                throw std::runtime_error("Cannot open file " + runs.back());
+            for (auto i : order)
+                fout.write(&entries[i * entry_size], entry_size);
+            if (!fout)
+                throw std::runtime_error("Cannot write file " + runs.back());
+        }
+        return runs;
+    }
+
+    // Merge runs into one ordered stream of entries and remove them, the run readers buffer at most
+    // about budget bytes. If there are more runs than the budget can buffer at once, groups of them
+    // are merged into bigger runs first.
+    void merge_runs(std::vector<std::string> runs, RunFiles& run_files, std::size_t entry_size,
+        std::size_t budget, const std::function<void(const char*)>& emit)
+    {
+        std::size_t buf_size = std::max(entry_size, std::size_t(1) << 20);
+        std::size_t fan_in = std::max<std::size_t>(2, budget / buf_size);
+
+        while (runs.size() > fan_in)
+        {
+            std::vector<std::string> merged_runs;
+            for (std::size_t i = 0; i < runs.size(); i += fan_in)
+            {
+                std::vector<std::string> group(runs.begin() + i, runs.begin() + std::min(runs.size(), i + fan_in));
+                merged_runs.push_back(run_files.next());
+                std::ofstream fout(merged_runs.back(), std::ios::binary);
+                if (!fout)
+                    throw std::runtime_error("Cannot open file " + merged_runs.back());
+                merge_group(group, entry_size, budget / group.size(), [&](const char* entry)
+                {
+                    fout.write(entry, entry_size);
+                });
+                if (!fout)
+                    throw std::runtime_error("Cannot write file " + merged_runs.back());
+            }
+            runs = std::move(merged_runs);
+        }
+
+        if (!runs.empty())
+            merge_group(runs, entry_size, budget / runs.size(), emit);
+    }
+
+    void merge_group(const std::vector<std::string>& runs, std::size_t entry_size, std::size_t buf_size,
+        const std::function<void(const char*)>& emit)
+    {
+        {
+            std::vector<std::unique_ptr<RunReader>> readers;
+            for (const auto& run : runs)
+                readers.emplace_back(new RunReader(run, entry_size, buf_size));
+
+            // ties are broken by run index, which keeps the sort stable
+            auto greater = [&](std::size_t a, std::size_t b)
+            {
+                int cmp = std::memcmp(readers[a]->current(), readers[b]->current(), key.length);
+                return cmp > 0 || (cmp == 0 && a > b);
+            };
+            std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(greater)> heap(greater);
+            for (std::size_t i = 0; i < readers.size(); ++i)
+                if (!readers[i]->empty())
+                    heap.push(i);
+
+            while (!heap.empty())
+            {
+                std::size_t i = heap.top();
+                heap.pop();
+                emit(readers[i]->current());
+                readers[i]->advance();
+                if (!readers[i]->empty())
+                    heap.push(i);
+            }
+        }
+
+        for (const auto& run : runs)
+            std::remove(run.c_str());
+    }
+};
+
+// This class reads an ordered row index written by Sorter::build_index and runs range scans on it
+// without loading it into memory. The index file looks like this:
+//      0~7:   "DBFIDX02"
+//      8~11:  number of key columns, 12~15: key length, 16~23: number of entries, little endian
+//      24~:   16 bytes per key column, 0~10: field name, 11: field length, 12: field type
+//      then the entries in key order, each one is key + row number(4 bytes, little endian)
+// For example:
+//      OrderedIndex index("trade.time.idx");
+//      for (auto row : index.range({"093000"}, {"100000"}))
+//          ...
+struct OrderedIndex
+{
+    OrderedIndex(const std::string& filename) : fin(filename, std::ios::binary)
+    {
+        if (!fin)
+            throw std::runtime_error("Cannot open file " + filename);
+
+        std::string buf(24, '\0');
+        fin.read(&buf.at(0), buf.size());
+        if (!fin || buf.compare(0, 8, "DBFIDX02") != 0)
+            throw std::runtime_error("Not an ordered index file: " + filename);
+
+        std::size_t key_columns_cnt = read_le(&buf[8], 4);
+        entries_cnt = read_le(&buf[16], 8);
+
+        std::vector<std::string> field_names;
+        std::vector<std::size_t> field_lengths;
+        std::vector<char> field_types;
+        buf.assign(key_columns_cnt * 16, '\0');
+        if (!buf.empty())
+            fin.read(&buf.at(0), buf.size());
+        for (std::size_t i = 0; i < key_columns_cnt; ++i)
+        {
+            field_names.push_back(std::string(buf.substr(i * 16, 11).data()));
+            field_lengths.push_back((uint8_t)buf.at(i * 16 + 11));
+            field_types.push_back(buf.at(i * 16 + 12));
+        }
+        key = SortKey(std::move(field_names), std::move(field_lengths), std::move(field_types));
+        entries_begin = 24 + key_columns_cnt * 16;
+        entry_size = key.length + 4;
+    }
+
+    std::size_t size() const
+    {
+        return entries_cnt;
+    }
+
+    // Row number of the i-th record in key order
+    std::size_t row_at(std::size_t i)
+    {
+        std::string entry = read_entries(i, 1);
+        return read_le(&entry[key.length], 4);
+    }
+
+    // Call callback(row) for every record with lower <= key <= upper, in key order, until it returns false.
+    // lower and upper may give only the first few key columns, the remaining columns then match anything.
+    void range_scan(const std::vector<std::string>& lower, const std::vector<std::string>& upper,
+        const std::function<bool(std::size_t)>& callback)
+    {
+        std::string lower_key = key.encode(lower, '\0');
+        std::string upper_key = key.encode(upper, '\xFF');
+
+        // binary search for the first entry not less than lower_key
+        std::size_t l = 0, r = entries_cnt;
+        while (l < r)
+        {
+            std::size_t mid = l + (r - l) / 2;
+            if (std::memcmp(read_entries(mid, 1).data(), lower_key.data(), key.length) < 0)
+                l = mid + 1;
+            else
+                r = mid;
+        }
+
+        const std::size_t batch_size = 4096;
+        for (std::size_t i = l; i < entries_cnt; i += batch_size)
+        {
+            std::size_t n = std::min(batch_size, entries_cnt - i);
+            std::string entries = read_entries(i, n);
+            for (std::size_t j = 0; j < n; ++j)
+            {
+                const char* entry = entries.data() + j * entry_size;
+                if (std::memcmp(entry, upper_key.data(), key.length) > 0)
+                    return;
+                if (!callback(read_le(entry + key.length, 4)))
+                    return;
+            }
+        }
+    }
+
+    std::vector<std::size_t> range(const std::vector<std::string>& lower, const std::vector<std::string>& upper)
+    {
+        std::vector<std::size_t> rows;
+        range_scan(lower, upper, [&](std::size_t row)
+        {
+            rows.push_back(row);
+            return true;
+        });
+        return rows;
+    }
+
+    std::ifstream fin;
+    SortKey key;
+    std::size_t entries_cnt = 0;
+
+private:
+
+    static uint64_t read_le(const char* src, std::size_t bytes)
+    {
+        uint64_t value = 0;
+        for (std::size_t i = 0; i < bytes; ++i)
+            value |= uint64_t(uint8_t(src[i])) << (8 * i);
+        return value;
+    }
+
+    std::string read_entries(std::size_t entry_begin, std::size_t entries)
+    {
+        std::string buf(entries * entry_size, '\0');
+        fin.clear();
+        fin.seekg(entries_begin + entry_begin * entry_size, fin.beg);
+        fin.read(&buf.at(0), buf.size());
+        if (!fin)
+            throw std::runtime_error(
+                "Index file is too small to contain entries, need = " +
+                    std::to_string(entries_begin + (entry_begin + entries) * entry_size)
+            );
+        return buf;
+    }
+
+    std::size_t entries_begin = 0;
+    std::size_t entry_size = 0;
+};
+
+}
\ No newline at end of file
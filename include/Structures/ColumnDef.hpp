@@ -13,6 +13,7 @@ struct ColumnDef
         field_name = data.substr(0, 10);
         field_name = std::string(field_name.data()); // remove trailing '\0'
         field_name = trim(field_name);
+        field_type = data.at(11);
         field_length = (uint8_t)data.at(16);
     }
 
@@ -37,14 +38,15 @@ struct ColumnDef
     {
         std::stringstream ss;
         ss << "field_name: \"" << field_name << "\"" << std::endl;
-        ss << "field_type: Characters" << std::endl;
+        ss << "field_type: " << field_type << std::endl;
         ss << "field_length: " << field_length << std::endl;
 
         return ss.str();
     }
 
     std::string field_name = "";   // 0~10: Name of field
-    char field_type = 'C';         // 11: 'C stands for String type, we only support string type
+    char field_type = 'C';         // 11: 'C' stands for String type, we only write string type,
+                                   //     'N'/'F' numbers, 'D' dates and 'L' logicals are kept when loaded
     // 12~15 : not used, fill with zeros
     std::size_t field_length = 0;       // 16: length of field
     // 17~31 : not used, fill with zero
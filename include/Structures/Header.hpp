@@ -20,7 +20,7 @@ struct Header
         }
 
         // read file into header_data
-        for (std::size_t i = 0; i < 12ull; i++)
+        for (std::size_t i = 0; i < 32ull; i++)
         {
             current_byte = data.at(i);
 
@@ -81,7 +81,7 @@ struct Header
             }
             case 29:
             {
-                // code_page_mark
+                code_page_mark = current_byte;
                 break;
             }
 
@@ -113,6 +113,8 @@ struct Header
         ret[10] = (bytes_per_record & 0xFF);
         ret[11] = ((bytes_per_record >> 8) & 0xFF);
 
+        ret[29] = code_page_mark;
+
         return ret;
     }
 
@@ -125,6 +127,7 @@ struct Header
         ss << "Number of records:\t\t\t" << (int)records_cnt << std::endl;
         ss << "Number of bytes in header:\t\t" << (int)header_total_bytes << std::endl;
         ss << "Number of bytes per record:\t\t" << (int)bytes_per_record << std::endl;
+        ss << "Code page mark:\t\t\t\t" << (int)code_page_mark << std::endl;
 
         return ss.str();
     }
@@ -134,7 +137,9 @@ struct Header
     uint32_t records_cnt = 0;          /// BYTE 4-7, 32-bit, number of records
     uint64_t header_total_bytes = 0;   /// BYTE 8-9, 16 bit, number of bytes in header(including column definitions)
     uint16_t bytes_per_record = 0;    /// BYTE 10-11, 16 bit, number of bytes in one record
-    /// BYTE 12-31 are zeros
+    /// BYTE 12-28 are zeros
+    uint8_t code_page_mark = 0;       /// BYTE 29, code page of text fields, e.g. 0x7A for GBK
+    /// BYTE 30-31 are zeros
 };
 
 }
\ No newline at end of file
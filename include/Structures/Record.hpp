@@ -6,6 +6,7 @@
 #include <map>
 #include "Utils.hpp"
 #include "ColumnDef.hpp"
+#include "Encoding/CodePage.hpp"
 
 namespace DBaseTools
 {
@@ -29,20 +30,30 @@ struct Record
         const std::vector<std::shared_ptr<ColumnDef>>& col_defs
         ) const
     {
-        std::string ret(header->bytes_per_record, '\0');
-        std::size_t curPos = 0;
+        std::string ret(header->bytes_per_record, ' '); // fields are padded with spaces
+        ret.at(0) = 0x20; // deleted flag, 0x20 means not deleted
+        std::size_t curPos = 1;
         for (std::size_t i = 0; i < col_defs.size(); ++i)
         {
             std::string k = col_defs[i]->field_name;
             std::string v = contents.at(k);
             std::size_t field_length = col_defs[i]->field_length;
-            ret.at(curPos) = 0x20; // deleted flag, 0x20 means not deleted
-            ret.replace(curPos+1, std::min(field_length-1, v.size()), v); // +1 for deleted flag, 0x20 means not deleted
+            ret.replace(curPos, std::min(field_length, v.size()), v);
             curPos += field_length;
         }
         return ret;
     }
 
+    // Value of a field as UTF-8, contents keep the raw bytes and are only transcoded here.
+    // The '\0' padding that trim leaves behind is dropped first.
+    std::string text(const std::string& field_name, uint8_t code_page_mark) const
+    {
+        const std::string& value = contents.at(field_name);
+        std::size_t l = 0, r = value.size();
+        trim_field(value.data(), l, r);
+        return to_utf8(value.substr(l, r - l), code_page_mark);
+    }
+
     std::string to_debug_string(char sep='\n') const
     {
         std::stringstream ss;
@@ -0,0 +1,194 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include "Utils.hpp"
+#include "Table.hpp"
+
+namespace DBaseTools
+{
+
+// Sort keys are built from the raw field bytes and compared with memcmp, column by column:
+//  - 'N'/'F' columns take 1 + 2 * field_length bytes: a sign byte (blank < negative < non-negative
+//    < not a number), the integer digits right-aligned and the fraction digits left-aligned, both
+//    padded with '0'. Digits of negative numbers are complemented (d -> 9 - d), so larger magnitudes
+//    come first and the keys compare in numeric order. A value whose exponent pushes its digits
+//    beyond the field length cannot be placed and throws.
+//  - other columns drop the blanks around the value and are padded with '\0', so they compare
+//    like the trimmed strings
+// With numeric_order = false every column is kept as trimmed text, which is enough to tell values
+// apart (e.g. for group-by) and lets the values be read back from the key.
+struct SortKey
+{
+    SortKey() = default;
+
+    SortKey(std::shared_ptr<const Table> schema, const std::vector<std::string>& key_columns,
+        bool numeric_order = true)
+        : numeric_order(numeric_order)
+    {
+        if (key_columns.empty())
+            throw std::runtime_error("SortKey: key_columns is empty");
+
+        auto offsets = schema->field_offsets();
+        for (const auto& field_name : key_columns)
+        {
+            std::size_t column_index = schema->column_index(field_name);
+            field_names.push_back(field_name);
+            field_offsets.push_back(offsets[column_index]);
+            field_lengths.push_back(schema->col_defs[column_index]->field_length);
+            field_types.push_back(schema->col_defs[column_index]->field_type);
+            length += width(field_names.size() - 1);
+        }
+    }
+
+    SortKey(std::vector<std::string> field_names, std::vector<std::size_t> field_lengths,
+        std::vector<char> field_types)
+        : field_names(std::move(field_names)), field_lengths(std::move(field_lengths)),
+          field_types(std::move(field_types))
+    {
+        for (std::size_t i = 0; i < this->field_lengths.size(); ++i)
+            length += width(i);
+    }
+
+    // Build the key of one raw record into dst, dst must hold length bytes
+    void extract(const char* record, char* dst) const
+    {
+        for (std::size_t i = 0; i < field_offsets.size(); ++i)
+        {
+            const char* field = record + field_offsets[i];
+            std::size_t l = 0, r = field_lengths[i];
+            trim_field(field, l, r);
+            place(dst, field + l, r - l, i);
+            dst += width(i);
+        }
+    }
+
+    // Build a key from field values, columns not given are filled with fill_byte,
+    // so '\0' makes a lowest bound and '\xFF' makes a highest bound
+    std::string encode(const std::vector<std::string>& values, char fill_byte) const
+    {
+        if (values.size() > field_lengths.size())
+            throw std::runtime_error(
+                "Too many key values, key_columns = " + std::to_string(field_lengths.size()) +
+                    ", values = " + std::to_string(values.size())
+            );
+
+        std::string ret(length, fill_byte);
+        std::size_t cur_pos = 0;
+        for (std::size_t i = 0; i < field_lengths.size(); ++i)
+        {
+            if (i < values.size())
+            {
+                std::string value = trim(values[i]);
+                if (value.size() > field_lengths[i])
+                    throw std::runtime_error(
+                        "Value of key [" + field_names[i] + "] is too long! " +
+                            "Limit = " + std::to_string(field_lengths[i]) + ", " +
+                            "Actual = " + std::to_string(value.size())
+                    );
+                place(&ret[cur_pos], value.data(), value.size(), i);
+            }
+            cur_pos += width(i);
+        }
+        return ret;
+    }
+
+    bool is_numeric(std::size_t i) const
+    {
+        return numeric_order && (field_types[i] == 'N' || field_types[i] == 'F');
+    }
+
+    // Number of key bytes of column i
+    std::size_t width(std::size_t i) const
+    {
+        return is_numeric(i) ? 1 + 2 * field_lengths[i] : field_lengths[i];
+    }
+
+    std::vector<std::string> field_names;
+    std::vector<std::size_t> field_offsets;
+    std::vector<std::size_t> field_lengths;
+    std::vector<char> field_types;
+    bool numeric_order = true;
+    std::size_t length = 0;
+
+private:
+
+    // Write a trimmed value of column i into its width(i) bytes of the key
+    void place(char* dst, const char* value, std::size_t size, std::size_t i) const
+    {
+        if (is_numeric(i))
+            place_number(dst, value, size, i);
+        else
+        {
+            std::memcpy(dst, value, size);
+            std::memset(dst + size, '\0', field_lengths[i] - size);
+        }
+    }
+
+    void place_number(char* dst, const char* value, std::size_t size, std::size_t i) const
+    {
+        const char BLANK = 0x00, NEGATIVE = 0x01, NON_NEGATIVE = 0x02, NOT_A_NUMBER = 0x03;
+        std::size_t field_length = field_lengths[i];
+        std::memset(dst, '\0', width(i));
+
+        NumberText number;
+        if (size == 0)
+        {
+            dst[0] = BLANK;
+            return;
+        }
+        if (!scan_number(value, size, number))
+        {
+            dst[0] = NOT_A_NUMBER;
+            std::memcpy(dst + 1, value, size);
+            return;
+        }
+
+        // all digits, and the position of the point in them once the exponent is applied
+        std::string digits(number.int_digits, number.int_size);
+        digits.append(number.frac_digits, number.frac_size);
+        std::size_t first = digits.find_first_not_of('0');
+        bool zero = first == std::string::npos;
+
+        std::string int_part, frac_part;
+        if (!zero)
+        {
+            long point = long(number.int_size) + number.exponent;
+            if (point > long(first + field_length) || point < long(first) - long(field_length))
+                throw_cannot_order(value, size, i);
+            if (point < 0)
+                digits.insert(0, std::size_t(-point), '0'), point = 0;
+            if (point > long(digits.size()))
+                digits.append(std::size_t(point) - digits.size(), '0');
+
+            int_part = digits.substr(0, point);
+            frac_part = digits.substr(point);
+            int_part.erase(0, std::min(int_part.find_first_not_of('0'), int_part.size()));
+            frac_part.erase(frac_part.find_last_not_of('0') + 1);
+            if (int_part.size() > field_length || frac_part.size() > field_length)
+                throw_cannot_order(value, size, i);
+        }
+
+        bool negative = number.negative && !zero;
+        dst[0] = negative ? NEGATIVE : NON_NEGATIVE;
+        char* int_begin = dst + 1;
+        char* frac_begin = dst + 1 + field_length;
+        std::memset(int_begin, '0', 2 * field_length);
+        std::memcpy(frac_begin - int_part.size(), int_part.data(), int_part.size());
+        std::memcpy(frac_begin, frac_part.data(), frac_part.size());
+        if (negative)
+            for (std::size_t k = 0; k < 2 * field_length; ++k)
+                int_begin[k] = char('0' + '9' - int_begin[k]);
+    }
+
+    void throw_cannot_order(const char* value, std::size_t size, std::size_t i) const
+    {
+        throw std::runtime_error(
+            "Value of key [" + field_names[i] + "] has more digits than the field can order, value = \"" +
+                std::string(value, size) + "\""
+        );
+    }
+};
+
+}
\ No newline at end of file
@@ -34,6 +34,33 @@ struct Table
         return ss.str();
     }
 
+    // Offset of each column inside one raw record, byte 0 is the deleted flag
+    std::vector<std::size_t> field_offsets() const
+    {
+        std::vector<std::size_t> offsets;
+        std::size_t cur_pos = 1;
+        for (const auto& col_def : col_defs)
+        {
+            offsets.push_back(cur_pos);
+            cur_pos += col_def->field_length;
+        }
+        return offsets;
+    }
+
+    // Value of a field as UTF-8, transcoded from the code page in the header
+    std::string text(std::size_t row, const std::string& field_name) const
+    {
+        return records.at(row)->text(field_name, header->code_page_mark);
+    }
+
+    std::size_t column_index(const std::string& field_name) const
+    {
+        for (std::size_t i = 0; i < col_defs.size(); ++i)
+            if (col_defs[i]->field_name == field_name)
+                return i;
+        throw std::runtime_error("Cannot find column " + field_name);
+    }
+
     std::shared_ptr<Header> header;
     std::vector<std::shared_ptr<ColumnDef>> col_defs;
     std::vector<std::shared_ptr<Record>> records;
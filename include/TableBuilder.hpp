@@ -30,7 +30,7 @@ struct TableBuilder
         {
             auto col_def = std::make_shared<ColumnDef>();
             col_def->field_name = std::get<0>(name_length_tuple);
-            col_def->field_length = std::get<1>(name_length_tuple) + 1; // +1 for deleted flag
+            col_def->field_length = std::get<1>(name_length_tuple);
             col_defs.emplace_back(std::move(col_def));
         }
 
@@ -76,6 +76,13 @@ struct TableBuilder
         regenerate_header();
     }
 
+    // Mark the encoding of text fields, e.g. CODE_PAGE_MARK_GBK. Values are stored as given, not transcoded.
+    void set_code_page_mark(uint8_t code_page_mark)
+    {
+        regenerate_header();
+        table->header->code_page_mark = code_page_mark;
+    }
+
     std::shared_ptr<Table> table;
 
 private:
@@ -86,7 +93,7 @@ private:
         header->records_cnt = table->records.size();
         header->header_total_bytes = 32 + table->col_defs.size() * 32 + 1; // header(32) + column_defs(32 * n) + terminator(1)
 
-        header->bytes_per_record = 0;
+        header->bytes_per_record = 1; // deleted flag
         for (auto col_def : table->col_defs)
             header->bytes_per_record += col_def->field_length;
 
@@ -95,6 +102,9 @@ private:
         auto now_tm = std::localtime(&now_time_t);
         header->last_updated = (now_tm->tm_year) | (now_tm->tm_mon + 1 << 8) | (now_tm->tm_mday << 16);
 
+        if (table->header)
+            header->code_page_mark = table->header->code_page_mark;
+
         table->header = std::move(header);
     }
 
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <cstddef>
 
 namespace DBaseTools
 {
@@ -12,5 +13,65 @@ std::string trim(const std::string& s)
     return s.substr(l, r-l);
 }
 
+// Narrow [l, r) of a raw field to its value, dropping the space and '\0' padding on both sides
+inline void trim_field(const char* data, std::size_t& l, std::size_t& r)
+{
+    while (l < r && (data[l] == ' ' || data[l] == '\0')) ++l;
+    while (l < r && (data[r - 1] == ' ' || data[r - 1] == '\0')) --r;
+}
+
+// Parts of a decimal such as "-12.50" or "1.5E+03", found by scan_number.
+// The digit pointers point into the scanned value.
+struct NumberText
+{
+    bool negative = false;
+    const char* int_digits = nullptr;
+    std::size_t int_size = 0;
+    const char* frac_digits = nullptr;
+    std::size_t frac_size = 0;
+    long exponent = 0;
+};
+
+// Scan a trimmed value as [+-]digits[.digits][(e|E)[+-]digits], return false if it is not a number.
+// At least one digit is needed before the exponent, "12." and ".5" are numbers.
+inline bool scan_number(const char* data, std::size_t size, NumberText& number)
+{
+    number = NumberText();
+    std::size_t i = 0;
+    if (i < size && (data[i] == '-' || data[i] == '+'))
+        number.negative = data[i++] == '-';
+
+    number.int_digits = data + i;
+    while (i < size && data[i] >= '0' && data[i] <= '9') ++i;
+    number.int_size = data + i - number.int_digits;
+
+    number.frac_digits = data + i;
+    if (i < size && data[i] == '.')
+    {
+        number.frac_digits = data + ++i;
+        while (i < size && data[i] >= '0' && data[i] <= '9') ++i;
+        number.frac_size = data + i - number.frac_digits;
+    }
+    if (number.int_size + number.frac_size == 0)
+        return false;
+
+    if (i < size && (data[i] == 'e' || data[i] == 'E'))
+    {
+        bool negative_exponent = false;
+        if (++i < size && (data[i] == '-' || data[i] == '+'))
+            negative_exponent = data[i++] == '-';
+
+        std::size_t exponent_begin = i;
+        for (; i < size && data[i] >= '0' && data[i] <= '9'; ++i)
+            if (number.exponent < 100000) // far beyond any double, keeps it from overflowing
+                number.exponent = number.exponent * 10 + (data[i] - '0');
+        if (i == exponent_begin)
+            return false;
+        if (negative_exponent)
+            number.exponent = -number.exponent;
+    }
+    return i == size;
+}
+
 
 }
\ No newline at end of file
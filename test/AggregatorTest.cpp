@@ -0,0 +1,106 @@
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include "DBaseTools.hpp"
+
+using namespace DBaseTools;
+
+static int failures = 0;
+
+static void check(bool ok, const std::string& what)
+{
+    if (!ok)
+    {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+// Write a dbf file in the standard layout: records start at header_total_bytes, each one is
+// a deletion flag followed by the fields, numbers are right-aligned
+static void write_standard_dbf(const std::string& filename)
+{
+    struct Field { const char* name; char type; uint8_t length; };
+    const Field fields[] = { {"CODE", 'C', 6}, {"QTY", 'N', 8}, {"PRICE", 'F', 10} };
+    struct Row { char flag; const char* code; const char* qty; const char* price; };
+    const Row rows[] = {
+        {' ', "600000", "1000", "10.5"},
+        {' ', "600001", "-50", "1.5E+03"},
+        {' ', "600000", "93", "-2.25"},
+        {' ', "600001", "", "4"},
+        {'*', "600000", "7777", "99"},
+        {' ', "600002", "-5", ""},
+    };
+    const std::size_t fields_cnt = sizeof(fields) / sizeof(fields[0]);
+    const std::size_t rows_cnt = sizeof(rows) / sizeof(rows[0]);
+    const std::size_t header_total_bytes = 32 + fields_cnt * 32 + 1;
+    const std::size_t bytes_per_record = 1 + 6 + 8 + 10;
+
+    std::string data(32, '\0');
+    data[0] = 0x03;
+    data[4] = char(rows_cnt);
+    data[8] = char(header_total_bytes & 0xFF);
+    data[9] = char(header_total_bytes >> 8);
+    data[10] = char(bytes_per_record);
+    for (const auto& field : fields)
+    {
+        std::string col_def(32, '\0');
+        col_def.replace(0, std::strlen(field.name), field.name);
+        col_def[11] = field.type;
+        col_def[16] = char(field.length);
+        data += col_def;
+    }
+    data.push_back(0x0D);
+    for (const auto& row : rows)
+    {
+        data.push_back(row.flag);
+        const char* values[] = { row.code, row.qty, row.price };
+        for (std::size_t c = 0; c < fields_cnt; ++c)
+        {
+            std::string value = values[c];
+            std::string padding(fields[c].length - value.size(), ' ');
+            data += fields[c].type == 'C' ? value + padding : padding + value;
+        }
+    }
+    data.push_back(0x1A);
+
+    std::ofstream fout(filename, std::ios::binary);
+    fout.write(data.data(), data.size());
+}
+
+int main()
+{
+    const std::string filename = "aggregator_test.dbf";
+    write_standard_dbf(filename);
+
+    for (std::size_t threads : {1, 3})
+    {
+        std::string tag = " (threads = " + std::to_string(threads) + ")";
+        auto result = Aggregator(filename, {"CODE"}, {"QTY", "PRICE"}, threads, 2).aggregate();
+        check(result.size() == 3, "three groups" + tag);
+
+        const auto& a = result[{"600000"}];
+        check(a.count == 2, "deleted row is not counted" + tag);
+        check(a.sum[0] == 1093 && a.min[0] == 93 && a.max[0] == 1000, "QTY of 600000" + tag);
+        check(a.sum[1] == 8.25 && a.min[1] == -2.25, "PRICE of 600000" + tag);
+
+        const auto& b = result[{"600001"}];
+        check(b.count == 2 && b.values_count[0] == 1 && b.sum[0] == -50, "blank QTY is skipped" + tag);
+        check(b.sum[1] == 1504 && b.max[1] == 1500, "exponent in PRICE" + tag);
+
+        const auto& c = result[{"600002"}];
+        check(c.count == 1 && c.values_count[1] == 0 && c.min[1] != c.min[1], "blank PRICE gives NaN" + tag);
+    }
+
+    auto by_qty = Aggregator(filename, {"QTY"}, {"PRICE"}).aggregate();
+    check(by_qty.count({"-50"}) == 1 && by_qty.count({""}) == 1, "numeric group keys come back trimmed");
+
+    auto total = Aggregator(filename, {}, {"QTY"}).aggregate();
+    check(total[{}].count == 5 && total[{}].sum[0] == 1038, "total without group columns");
+
+    std::remove(filename.c_str());
+    if (failures == 0)
+        std::cout << "All aggregator tests passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}